@@ -0,0 +1,602 @@
+import os
+import re
+import glob
+import shutil
+import subprocess
+
+from typing import List
+
+'''
+File info:
+    Name    - [interface_patch]
+    Date    - [Aug. 26, 2026]
+    Exe     - [No]
+File description:
+    Post-codegen performance patches for the C interface that opengen generates
+    into the solver build directory (icasadi_*/extern/interface.c). The generated
+    scalar code is rewritten after "builder.build()" and the solver is re-compiled
+    with cargo so the patches take effect in the shipped .so.
+Comments:
+    All patches are textual and anchored on the opengen template. A patch that
+    cannot find its anchor raises PatchError instead of silently shipping an
+    unpatched solver. Opengen re-generates the sources on every build, so the
+    patches are re-applied every time the MPC module is (re)built.
+'''
+
+MEMCPY_COPY_HEADER = r'''
+/* --- patched: bulk staging copy via memcpy (see interface_patch.py) --- */
+#include <string.h>
+/* --- end patch --- */
+
+'''
+
+BATCH_ENTRY_TEMPLATE = r'''
+/* --- patched: batched entry points (see interface_patch.py) --- */
+/* Run {batch} independent evaluations; each thread uses its own
+ * _Thread_local scratch, so the loop is embarrassingly parallel. */
+int {entry}_batch(int batch_size, const casadi_real** args_batch, casadi_real** res_batch) {{
+    int b;
+    int status = 0;
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) reduction(|:status)
+#endif
+    for (b = 0; b < batch_size; b++) {{
+        status |= {entry}(args_batch + {n_in}*b, res_batch + {n_out}*b);
+    }}
+    return status;
+}}
+/* --- end patch --- */
+'''
+
+COST_AND_GRAD_TEMPLATE = r'''
+/* --- patched: fused cost+gradient evaluation (see interface_patch.py) --- */
+/* PANOC-style iterations evaluate phi and its gradient back to back on the
+ * same (u, xi, p); fuse them behind one call so the argument setup (and the
+ * staging copy, when kept) happens once. res[0] = cost, res[1] = gradient. */
+int cost_and_grad_function_{name}(const casadi_real** arg, casadi_real** res) {{
+    int status = cost_function_{name}(arg, res);
+    return status | grad_cost_function_{name}(arg, res + 1);
+}}
+/* --- end patch --- */
+'''
+
+HUGEPAGE_HELPER = r'''
+/* --- patched: transparent-hugepage advice for large workspaces (see interface_patch.py) --- */
+#if defined(__linux__)
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/mman.h>
+/* Strict ISO modes hide the GNU madvise interface; fall back to the
+ * stable Linux UAPI declaration/value. */
+extern int madvise(void* addr, size_t length, int advice);
+#if !defined(MADV_HUGEPAGE)
+#define MADV_HUGEPAGE 14
+#endif
+#endif
+
+static inline void hugepage_advise_once(const void* addr, size_t len, int* advised) {
+#if defined(__linux__)
+    if (!*advised) {
+        uintptr_t start = ((uintptr_t)addr) & ~((uintptr_t)4095);
+        /* Best effort: ask the kernel to back the containing region with THP
+         * so the first-touch fault and DTLB pressure drop out of the MPC tick. */
+        (void)madvise((void*)start, len + ((uintptr_t)addr - start), MADV_HUGEPAGE);
+        *advised = 1;
+    }
+#else
+    (void)addr; (void)len; (void)advised;
+#endif
+}
+/* --- end patch --- */
+
+'''
+
+EVAL_ALL_TEMPLATE = r'''
+/* --- patched: one-shot dispatcher (see interface_patch.py) --- */
+/* ALM/penalty loops evaluate cost, gradient and both constraint mappings
+ * back to back on the same iterate; run all four behind one call so the
+ * argument handling happens once. arg = (u, xi, p); the mappings take (u, p). */
+int eval_all_{name}(const casadi_real** arg, casadi_real* phi, casadi_real* grad, casadi_real* f1, casadi_real* f2) {{
+    const casadi_real* arg_up[2];
+    casadi_real* res__[1];
+    int status = 0;
+    arg_up[0] = arg[0];
+    arg_up[1] = arg[2];
+    res__[0] = phi;  status |= cost_function_{name}(arg, res__);
+    res__[0] = grad; status |= grad_cost_function_{name}(arg, res__);
+    res__[0] = f1;   status |= mapping_f1_function_{name}(arg_up, res__);
+    res__[0] = f2;   status |= mapping_f2_function_{name}(arg_up, res__);
+    return status;
+}}
+/* --- end patch --- */
+'''
+
+NT_STORE_HELPER = r'''
+/* --- patched: non-temporal p copy (see interface_patch.py) --- */
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* The p block is written once and then only streamed through by the kernel,
+ * so store it past the cache to skip the read-for-ownership traffic. dst is
+ * the 64-byte-aligned p buffer; the scalar tail handles the odd remainder. */
+static inline void stream_copy_p(casadi_real* dst, const casadi_real* src, int n) {
+    int i = 0;
+#if defined(__AVX512F__)
+    for (; i + 8 <= n; i += 8)
+        _mm512_stream_pd(dst + i, _mm512_loadu_pd(src + i));
+    _mm_sfence();
+#elif defined(__AVX2__)
+    for (; i + 4 <= n; i += 4)
+        _mm256_stream_pd(dst + i, _mm256_loadu_pd(src + i));
+    _mm_sfence();
+#endif
+    for (; i < n; i++)
+        dst[i] = src[i];
+}
+/* --- end patch --- */
+
+'''
+
+class PatchError(Exception):
+    '''Raised when a patch anchor is not found in the generated sources.'''
+    pass
+
+
+class InterfacePatcher:
+    '''
+    Description:
+        Patch the auto-generated solver interface (interface.c) after opengen has
+        generated it, then rebuild the solver so the patches land in the binary.
+    Arguments:
+        build_directory <str>  - Build directory of the solver (config.build_directory).
+        optimizer_name  <str>  - Name of the optimizer (config.optimizer_name).
+        build_type      <str>  - 'debug' or 'release' (config.build_type).
+        alias_args      <bool> - If true (default), drop the (u, xi, p) staging copy and
+                                 alias the caller buffers; otherwise keep the copy but
+                                 vectorize it (for callers that rely on the staging buffer).
+        verbose         <bool> - If true, print patch progress.
+    Attributes:
+        solver_dir <str> - "{build_directory}/{optimizer_name}", root of the generated crate.
+    Functions:
+        apply_all <run> - Apply all patches and re-run cargo.
+    '''
+    def __init__(self, build_directory:str, optimizer_name:str, build_type:str='release', alias_args:bool=True, verbose:bool=True):
+        self.__print_name = '[MPC-Patch]'
+        self.optimizer_name = optimizer_name
+        self.build_type = build_type
+        self.alias_args = alias_args
+        self.vb = verbose
+        self.solver_dir = os.path.join(build_directory, optimizer_name)
+
+    def apply_all(self, rebuild:bool=True):
+        interface_path = self._find_interface_c()
+        with open(interface_path, 'r') as f:
+            code = f.read()
+        if self.alias_args:
+            code = self._patch_alias_args(code)
+        else:
+            code = self._patch_memcpy_copy(code)
+            code = self._patch_static_args(code)
+            code = self._patch_hot_cold_split(code)
+            code = self._patch_prefetch_p(code)
+            code = self._patch_nt_store_p(code)
+        code = self._patch_thread_local(code)
+        code = self._patch_workspace_arena(code)
+        code = self._patch_batch_entry(code)
+        code = self._patch_cost_and_grad(code)
+        code = self._patch_eval_all(code)
+        code = self._patch_restrict(code)
+        code = self._patch_hugepages(code)
+        with open(interface_path, 'w') as f:
+            f.write(code)
+        if self.vb:
+            print(f'{self.__print_name} Patched {interface_path}.')
+        self._patch_build_script_openmp()
+        self._patch_cargo_profile()
+        if rebuild:
+            self._rebuild()
+
+    def _find_interface_c(self) -> str:
+        matches = glob.glob(os.path.join(self.solver_dir, 'icasadi_*', 'extern', 'interface.c'))
+        if not matches:
+            raise PatchError(f'No generated interface.c under {self.solver_dir}. Run builder.build() first.')
+        return matches[0]
+
+    def _patch_alias_args(self, code:str) -> str:
+        '''Skip the (u, xi, p) staging copy altogether: the CasADi entry points only
+        need an array of input pointers, not contiguous storage, so args__ can alias
+        the caller buffers directly. Removes ~2.7K double loads+stores per call and
+        the ~21 KB uxip_space BSS region. The fastest copy is no copy.'''
+        code, n_calls = re.subn(r'[ \t]*copy_args_into_(?:uxip|up)_space\(arg\);\s*\n', '', code)
+        if n_calls < 2:
+            raise PatchError(f'Alias patch: expected >=2 staging-copy calls, found {n_calls}.')
+        # The input index matches the args__ index in both signatures:
+        # cost/grad take (u, xi, p), the F1/F2 mappings take (u, p).
+        code, n_args = re.subn(r'args__\[(\d+)\]\s*=\s*uxip_space[^;]*;', r'args__[\1] = arg[\1];', code)
+        if n_args < 4:
+            raise PatchError(f'Alias patch: expected >=4 args__ assignments, found {n_args}.')
+        # Drop the now-unused copy helpers and staging buffer
+        code, n_fn = re.subn(r'static void copy_args_into_(?:uxip|up)_space\(const casadi_real\s*\*\*\s*arg\)\s*\{.*?\n\}\s*\n',
+                             '', code, flags=re.DOTALL)
+        if n_fn != 2:
+            raise PatchError(f'Alias patch: expected 2 copy helpers, found {n_fn}.')
+        code, n_buf = re.subn(r'static casadi_real uxip_space\[[^\]]*\];[^\n]*\n', '', code)
+        if n_buf != 1:
+            raise PatchError(f'Alias patch: expected 1 uxip_space declaration, found {n_buf}.')
+        if self.vb:
+            print(f'{self.__print_name} Aliased caller buffers in {n_calls} entry points (staging copy removed).')
+        return code
+
+    def _patch_thread_local(self, code:str) -> str:
+        '''Make the file-scope scratch statics (CasADi integer/real workspaces,
+        result-pointer arrays, and the staging buffer if kept) thread-local, so the
+        cost/grad/F1/F2 entry points can be evaluated from parallel loops (e.g.
+        Monte-Carlo scenario batches in the RL pipeline) without corrupting state.'''
+        scratch_names = ('allocated_i_workspace', 'allocated_r_workspace', 'result_space',
+                         'uxip_space', 'hot_uxi_space', 'p_space')
+        lines = code.split('\n')
+        n_decls = 0
+        for k, line in enumerate(lines):
+            if line.lstrip().startswith('static ') and '[' in line and any(n in line for n in scratch_names):
+                lines[k] = line.replace('static ', 'static _Thread_local ', 1)
+                n_decls += 1
+        if n_decls < 8: # 4 entry points x (iw, w) at minimum
+            raise PatchError(f'Thread-local patch: expected >=8 scratch declarations, found {n_decls}.')
+        if self.vb:
+            print(f'{self.__print_name} Made {n_decls} scratch declarations thread-local.')
+        return '\n'.join(lines)
+
+    def _patch_static_args(self, code:str) -> str:
+        '''Staging mode only: args__ always points at the same fixed offsets into
+        uxip_space, yet every call rebuilds it on the stack. Promote it to a
+        thread-local static filled on first call, so repeated cost/grad/F1/F2
+        evaluations skip the pointer-array setup entirely. (In alias mode the
+        entries are the caller pointers and must be refreshed each call, and the
+        setup is 2-3 register stores; nothing to hoist.)'''
+        code, n_decls = re.subn(r'(?<!static )const casadi_real\* args__\[',
+                                'static _Thread_local const casadi_real* args__[', code)
+        if n_decls < 2:
+            raise PatchError(f'Static-args patch: expected >=2 args__ declarations, found {n_decls}.')
+        # uxip_space is thread-local, so its address is not a constant expression:
+        # guard the existing offset assignments as a first-call init instead.
+        code, n_blocks = re.subn(r'((?:[ \t]*args__\[\d+\]\s*=\s*uxip_space[^;]*;\s*\n)+)',
+                                 '    if (args__[0] == 0) {\n\\1    }\n', code)
+        if n_blocks != n_decls:
+            raise PatchError(f'Static-args patch: {n_decls} declarations but {n_blocks} assignment blocks.')
+        if self.vb:
+            print(f'{self.__print_name} Hoisted {n_decls} args__ arrays to first-call-initialized statics.')
+        return code
+
+    def _patch_workspace_arena(self, code:str) -> str:
+        '''Pack the per-entry scratch arrays (integer/real workspaces and
+        result-pointer arrays) into one contiguous thread-local struct, laid out in
+        the cost -> grad -> f1 -> f2 call order the solver rotates through. One
+        arena means one BSS/TLS region instead of twelve scattered ones, fewer DTLB
+        entries and better prefetch locality across consecutive evaluations. The
+        original names are kept as macros so every existing reference still works.'''
+        decl_pattern = re.compile(
+            r'static _Thread_local ((?:const )?casadi_(?:int|real)\s*\*?)\s*'
+            r'(allocated_[ir]_workspace_\w+|result_space_\w+)\[([^\]]+)\];[^\n]*\n')
+        decls = list(decl_pattern.finditer(code))
+        if len(decls) < 8: # 4 entry points x (iw, w) at minimum
+            raise PatchError(f'Arena patch: expected >=8 scratch declarations, found {len(decls)}.')
+        entry_rank = {'cost':0, 'grad':1, 'f1':2, 'f2':3}
+        kind_rank = {'allocated_i_workspace':0, 'allocated_r_workspace':1, 'result_space':2}
+        def call_order(match:re.Match):
+            (kind, entry) = match.group(2).rsplit('_', 1)
+            return (entry_rank.get(entry, len(entry_rank)), kind_rank.get(kind, len(kind_rank)))
+        members = sorted(decls, key=call_order)
+        arena = ('/* --- patched: contiguous scratch arena in call order (see interface_patch.py) --- */\n'
+                 'static _Thread_local struct {\n'
+                 + ''.join(f'    {m.group(1).strip()} {m.group(2)}[{m.group(3)}];\n' for m in members)
+                 + '} solver_scratch;\n'
+                 + ''.join(f'#define {m.group(2)} (solver_scratch.{m.group(2)})\n' for m in members)
+                 + '/* --- end patch --- */\n')
+        insert_at = decls[0].start() # earliest declaration, nothing removed before it
+        code = decl_pattern.sub('', code)
+        code = code[:insert_at] + arena + code[insert_at:]
+        if self.vb:
+            print(f'{self.__print_name} Packed {len(decls)} scratch arrays into one arena.')
+        return code
+
+    @staticmethod
+    def _sub_within(code:str, span_pattern:str, inner_fn) -> str:
+        '''Apply "inner_fn" to every span of "code" matching "span_pattern" (DOTALL).'''
+        out, last = [], 0
+        for match in re.finditer(span_pattern, code, flags=re.DOTALL):
+            out.append(code[last:match.start()])
+            out.append(inner_fn(match.group(0)))
+            last = match.end()
+        out.append(code[last:])
+        return ''.join(out)
+
+    def _patch_hot_cold_split(self, code:str) -> str:
+        '''Staging mode only: split uxip_space [u | xi | p] into a hot buffer for the
+        repeatedly-read u/xi blocks and a separate cold buffer for the once-streamed
+        p block, so the per-stage parameters stop sharing cache lines with ~21 KB of
+        horizon coefficients. The last input of every entry point is p.'''
+        decl = re.search(r'static casadi_real __attribute__\(\(aligned\(64\)\)\) uxip_space\[([^\]]*)\];[^\n]*\n', code)
+        if decl is None:
+            raise PatchError('Hot/cold patch: aligned uxip_space declaration not found.')
+        terms = [t.strip() for t in decl.group(1).split('+')]
+        if len(terms) != 3:
+            raise PatchError(f'Hot/cold patch: expected a 3-term (u, xi, p) buffer, found {decl.group(1)!r}.')
+        (nu, nxi, n_p) = terms
+        code = code.replace(decl.group(0),
+                            f'static casadi_real __attribute__((aligned(64))) hot_uxi_space[{nu} + {nxi}]; /* u, xi: read repeatedly */\n'
+                            f'static casadi_real __attribute__((aligned(64))) p_space[{n_p}]; /* p: streamed once per call */\n')
+        # Copy helpers: the last copied input (arg[2] resp. arg[1]) is p
+        def split_helper(body:str) -> str:
+            p_idx = max(int(i) for i in re.findall(r'arg\[(\d+)\]', body))
+            def fix(match:re.Match) -> str:
+                if int(match.group(2)) == p_idx:
+                    return f'memcpy(p_space, arg[{p_idx}]'
+                return match.group(0).replace('uxip_space', 'hot_uxi_space')
+            return re.sub(r'memcpy\(uxip_space([^,]*), arg\[(\d+)\]', fix, body)
+        code = self._sub_within(code, r'static void copy_args_into_(?:uxip|up)_space\(const casadi_real\s*\*\*\s*arg\)\s*\{.*?\n\}', split_helper)
+        # Entry points: the highest args__ index is p
+        def split_entry(body:str) -> str:
+            indices = [int(i) for i in re.findall(r'args__\[(\d+)\]\s*=\s*uxip_space', body)]
+            if not indices:
+                return body
+            p_idx = max(indices)
+            def fix(match:re.Match) -> str:
+                if int(match.group(1)) == p_idx:
+                    return f'args__[{p_idx}] = p_space;'
+                return match.group(0).replace('uxip_space', 'hot_uxi_space')
+            return re.sub(r'args__\[(\d+)\]\s*=\s*uxip_space[^;]*;', fix, body)
+        code = self._sub_within(code, r'int \w+\(const casadi_real\s*\*\*\s*arg, casadi_real\s*\*\*\s*res\)\s*\{.*?\n\}', split_entry)
+        if re.search(r'(?<!copy_args_into_)\buxip_space', code): # the helper *names* legitimately keep the old buffer name
+            raise PatchError('Hot/cold patch: stray uxip_space references remain after the split.')
+        if self.vb:
+            print(f'{self.__print_name} Split staging buffer into hot (u, xi) and cold (p) regions.')
+        return code
+
+    def _patch_prefetch_p(self, code:str) -> str:
+        '''Staging mode only: kick off prefetches for the head of the ~21 KB p block
+        before the small u/xi copies run, so the cold-buffer memcpy that follows
+        starts on warm lines (the hardware prefetcher takes over from there).'''
+        def add_prefetch(body:str) -> str:
+            p_idx = max(int(i) for i in re.findall(r'arg\[(\d+)\]', body))
+            head, brace, rest = body.partition('{')
+            return (head + brace +
+                    '\n    { /* warm the head of p while u/xi are copied */'
+                    '\n        int pf_;'
+                    '\n        for (pf_ = 0; pf_ < 8; pf_++)'
+                    f'\n            __builtin_prefetch((const char*)arg[{p_idx}] + 64*pf_, 0, 1);'
+                    '\n    }' + rest)
+        patched = self._sub_within(code, r'static void copy_args_into_(?:uxip|up)_space\(const casadi_real\s*\*\*\s*arg\)\s*\{.*?\n\}', add_prefetch)
+        if patched == code:
+            raise PatchError('Prefetch patch: no copy helpers found.')
+        if self.vb:
+            print(f'{self.__print_name} Added p prefetch to the copy helpers.')
+        return patched
+
+    def _patch_nt_store_p(self, code:str) -> str:
+        '''Staging mode only: copy the p block with non-temporal stores. p dominates
+        the copy volume and the destination lines would otherwise be pulled into the
+        cache (RFO) just to be overwritten; streaming stores skip that traffic.
+        Note the kernel re-reads p from memory afterwards, so this trades read
+        latency for write bandwidth -- a win on the bandwidth-bound tick preamble.'''
+        code, n_copies = re.subn(r'memcpy\(p_space, (arg\[\d+\]), \(([^)]+)\) \* sizeof\(casadi_real\)\);',
+                                 r'stream_copy_p(p_space, \1, \2);', code)
+        if n_copies < 2:
+            raise PatchError(f'NT-store patch: expected >=2 p copies, found {n_copies}.')
+        anchor = 'static void copy_args_into_'
+        if anchor not in code:
+            raise PatchError('NT-store patch: copy helper anchor not found.')
+        code = code.replace(anchor, NT_STORE_HELPER + anchor, 1)
+        if self.vb:
+            print(f'{self.__print_name} Switched {n_copies} p copies to non-temporal stores.')
+        return code
+
+    def _patch_batch_entry(self, code:str) -> str:
+        '''Append "<entry>_batch(B, args_batch, res_batch)" wrappers that fan B
+        independent evaluations out over an OpenMP parallel-for. Batched scenario
+        evaluation then needs one FFI crossing instead of B, and scales with cores
+        thanks to the thread-local scratch buffers.'''
+        # (entry point, number of inputs per element): cost/grad take (u, xi, p),
+        # the F1/F2 mappings take (u, p).
+        entries = [(f'cost_function_{self.optimizer_name}', 3),
+                   (f'grad_cost_function_{self.optimizer_name}', 3),
+                   (f'mapping_f1_function_{self.optimizer_name}', 2),
+                   (f'mapping_f2_function_{self.optimizer_name}', 2)]
+        n_added = 0
+        for entry, n_in in entries:
+            if f'int {entry}(' not in code:
+                raise PatchError(f'Batch patch: entry point {entry} not found.')
+            code += BATCH_ENTRY_TEMPLATE.format(entry=entry, n_in=n_in, n_out=1, batch='batch_size')
+            n_added += 1
+        if self.vb:
+            print(f'{self.__print_name} Added {n_added} batched entry points.')
+        return code
+
+    # C flags for the generated icasadi crate: OpenMP for the batched entry points,
+    # then full optimization + ISA + LTO so interface.c and the auto_casadi_*.c
+    # kernels can inline across translation units at (archive) link time.
+    C_BUILD_FLAGS = ['-fopenmp', '-O3', '-march=native', '-flto']
+
+    def _patch_cost_and_grad(self, code:str) -> str:
+        '''Expose a fused cost+gradient entry point. True graph-level fusion (one
+        CasADi function with two outputs sharing common subexpressions) would need
+        the kernels regenerated; the wrapper at least collapses the two FFI
+        crossings and the duplicated argument setup into one call.'''
+        for entry in (f'cost_function_{self.optimizer_name}', f'grad_cost_function_{self.optimizer_name}'):
+            if f'int {entry}(' not in code:
+                raise PatchError(f'Cost+grad patch: entry point {entry} not found.')
+        code += COST_AND_GRAD_TEMPLATE.format(name=self.optimizer_name)
+        if self.vb:
+            print(f'{self.__print_name} Added fused cost_and_grad_function_{self.optimizer_name}.')
+        return code
+
+    def _patch_eval_all(self, code:str) -> str:
+        '''Expose eval_all_<name>: one call that evaluates cost, gradient and both
+        constraint mappings on the same iterate, as ALM/penalty outer loops do.
+        Beyond saving three FFI crossings, a single call site keeps the four
+        kernels' shared inputs warm in cache across the back-to-back evaluations.'''
+        entries = [f'{prefix}_{self.optimizer_name}' for prefix in
+                   ('cost_function', 'grad_cost_function', 'mapping_f1_function', 'mapping_f2_function')]
+        for entry in entries:
+            if f'int {entry}(' not in code:
+                raise PatchError(f'eval_all patch: entry point {entry} not found.')
+        code += EVAL_ALL_TEMPLATE.format(name=self.optimizer_name)
+        if self.vb:
+            print(f'{self.__print_name} Added eval_all_{self.optimizer_name} dispatcher.')
+        return code
+
+    def _patch_restrict(self, code:str) -> str:
+        '''Qualify the arg/res pointer arrays of the entry points (and the copy
+        helpers, when kept) with restrict: the solver never aliases inputs with
+        results, but without the qualifier the compiler must assume it might,
+        blocking auto-vectorization once LTO inlines the kernels. restrict does
+        not change the ABI, so the Rust FFI declarations are unaffected; the
+        static buffers already carry aligned(64) for the alignment side.'''
+        code, n_entries = re.subn(r'\(const casadi_real\s*\*\*\s*arg, casadi_real\s*\*\*\s*res\)',
+                                  '(const casadi_real** restrict arg, casadi_real** restrict res)', code)
+        if n_entries < 4:
+            raise PatchError(f'Restrict patch: expected >=4 entry signatures, found {n_entries}.')
+        code, n_helpers = re.subn(r'\(const casadi_real\s*\*\*\s*arg\)',
+                                  '(const casadi_real** restrict arg)', code)
+        if self.vb:
+            print(f'{self.__print_name} Added restrict to {n_entries} entry points and {n_helpers} helpers.')
+        return code
+
+    def _patch_hugepages(self, code:str) -> str:
+        '''Advise the kernel (once per thread) to back each entry point's real-number
+        workspace with transparent hugepages, removing first-touch page faults and
+        DTLB misses from latency-critical MPC ticks. Purely advisory: on non-Linux
+        targets or when THP is disabled the call is a no-op.'''
+        anchor = 'static _Thread_local'
+        if anchor not in code:
+            raise PatchError('Hugepage patch: thread-local scratch anchor not found.')
+        code = code.replace(anchor, HUGEPAGE_HELPER + anchor, 1)
+        def add_advise(body:str) -> str:
+            workspace = re.search(r'allocated_r_workspace_\w+', body)
+            if workspace is None:
+                return body # forwarding wrapper, no workspace of its own
+            name = workspace.group(0)
+            head, brace, rest = body.partition('{')
+            return (head + brace +
+                    f'\n    static _Thread_local int hp_advised = 0;'
+                    f'\n    hugepage_advise_once({name}, sizeof({name}), &hp_advised);' + rest)
+        code = self._sub_within(code, r'int \w+\(const casadi_real\*\* restrict arg, casadi_real\*\* restrict res\)\s*\{.*?\n\}', add_advise)
+        if 'hugepage_advise_once(allocated_r_workspace' not in code:
+            raise PatchError('Hugepage patch: no workspace advise call was inserted.')
+        if self.vb:
+            print(f'{self.__print_name} Added hugepage advice to the entry-point workspaces.')
+        return code
+
+    def _pgo_flags(self) -> List[str]:
+        '''Profile-guided optimization of the generated kernels, driven by the
+        MPC_SOLVER_PGO environment variable: "generate" instruments the build,
+        any other value is taken as the directory of a previously recorded
+        profile to optimize with. The CasADi codegen is full of if_else branches
+        whose bias only shows up under real MPC inputs, so the two-phase build
+        is worth it for deployment; see LOG.md for the workflow (BOLT layout
+        of the final .so stays an external post-link step).'''
+        pgo = os.environ.get('MPC_SOLVER_PGO', '')
+        if not pgo:
+            return []
+        if pgo == 'generate':
+            return ['-fprofile-generate']
+        return [f'-fprofile-use={pgo}', '-fprofile-correction']
+
+    def _patch_build_script_openmp(self):
+        '''Inject the C compiler flags (C_BUILD_FLAGS plus any PGO phase flags) into
+        the generated icasadi build script; without -fopenmp the batched entries
+        fall back to a serial loop.'''
+        build_rs_matches = glob.glob(os.path.join(self.solver_dir, 'icasadi_*', 'build.rs'))
+        if not build_rs_matches:
+            print(f'{self.__print_name} WARNING: no icasadi build.rs found, C flags not applied.')
+            return
+        build_rs = build_rs_matches[0]
+        with open(build_rs, 'r') as f:
+            script = f.read()
+        if '-fopenmp' in script:
+            return # already patched
+        flag_chain = ''.join(f'\n        .flag_if_supported("{flag}")' for flag in self.C_BUILD_FLAGS + self._pgo_flags())
+        script, n_flags = re.subn(r'cc::Build::new\(\)', 'cc::Build::new()' + flag_chain, script)
+        if n_flags == 0:
+            print(f'{self.__print_name} WARNING: cc::Build anchor not found in build.rs, C flags not applied.')
+            return
+        script, n_link = re.subn(r'(\.compile\([^;]*;)', r'\1\n    println!("cargo:rustc-link-lib=gomp");', script, count=1)
+        with open(build_rs, 'w') as f:
+            f.write(script)
+        if self.vb:
+            print(f'{self.__print_name} Injected C flags {self.C_BUILD_FLAGS} into {build_rs}.')
+
+    def _patch_cargo_profile(self):
+        '''Turn on fat LTO and a single codegen unit for the release profile of the
+        generated solver crate, giving the Rust/C boundary whole-program visibility.'''
+        cargo_toml = os.path.join(self.solver_dir, 'Cargo.toml')
+        if not os.path.isfile(cargo_toml):
+            print(f'{self.__print_name} WARNING: no Cargo.toml found, release profile not tuned.')
+            return
+        with open(cargo_toml, 'r') as f:
+            manifest = f.read()
+        if '[profile.release]' in manifest:
+            return # profile already defined (opengen update?) -- leave it alone
+        manifest += '\n[profile.release]\nlto = true\ncodegen-units = 1\n'
+        with open(cargo_toml, 'w') as f:
+            f.write(manifest)
+        if self.vb:
+            print(f'{self.__print_name} Enabled LTO in {cargo_toml}.')
+
+    def _patch_memcpy_copy(self, code:str) -> str:
+        '''Replace the scalar element-copy loops in copy_args_into_uxip_space /
+        copy_args_into_up_space with memcpy: glibc dispatches to the widest copy
+        the CPU offers (AVX/AVX-512/ERMS) at runtime, beating both the scalar loop
+        and hand-rolled intrinsics without needing an ISA guard at compile time.'''
+        # The template copies with "for (i=0; i<N; i++) uxip_space[OFF+i] = arg[K][i];"
+        # An optional closing brace of the loop body must sit indented on its own
+        # line; matching any following "}" would swallow the helper's closing brace.
+        loop_pattern = re.compile(
+            r'for\s*\(\s*i\s*=\s*0;\s*i\s*<\s*([A-Za-z0-9_]+(?:\s*\+\s*[A-Za-z0-9_]+)*)\s*;\s*(?:i\+\+|\+\+i)\s*\)\s*\{?'
+            r'\s*uxip_space\[\s*(?:([A-Za-z0-9_]+(?:\s*\+\s*[A-Za-z0-9_]+)*)\s*\+\s*)?i\s*\]\s*=\s*arg\[(\d+)\]\[\s*i\s*\];[ \t]*(?:\n[ \t]+\})?')
+        def to_memcpy(match:re.Match) -> str:
+            length, offset, arg_idx = match.group(1), match.group(2), match.group(3)
+            dst = f'uxip_space + {offset}' if offset else 'uxip_space'
+            return f'memcpy({dst}, arg[{arg_idx}], ({length}) * sizeof(casadi_real));'
+        code, n_loops = loop_pattern.subn(to_memcpy, code)
+        if n_loops < 2:
+            raise PatchError(f'memcpy patch: expected >=2 copy loops, found {n_loops}.')
+        # Insert the include right before the first copy function
+        anchor = 'static void copy_args_into_'
+        if anchor not in code:
+            raise PatchError('memcpy patch: copy helper anchor not found.')
+        code = code.replace(anchor, MEMCPY_COPY_HEADER + anchor, 1)
+        # The loop counter is dead once the loops are gone
+        code = self._sub_within(code, r'static void copy_args_into_(?:uxip|up)_space\(const casadi_real\s*\*\*\s*arg\)\s*\{.*?\n\}',
+                                lambda body: re.sub(r'\n[ \t]*int i;', '', body))
+        # Align the (u, xi, p) buffer to a cache line
+        code, n_align = re.subn(r'static casadi_real uxip_space',
+                                'static casadi_real __attribute__((aligned(64))) uxip_space', code)
+        if n_align != 1:
+            raise PatchError(f'memcpy patch: expected 1 uxip_space declaration, found {n_align}.')
+        if self.vb:
+            print(f'{self.__print_name} Replaced {n_loops} copy loops with memcpy.')
+        return code
+
+    def _rebuild(self):
+        '''Re-run cargo on the patched sources, mirroring what opengen does,
+        and refresh the python-bindings .so next to the solver crate.'''
+        cargo_cmd = ['cargo', 'build']
+        if self.build_type == 'release':
+            cargo_cmd.append('--release')
+        if self.vb:
+            print(f'{self.__print_name} Rebuilding solver in {self.solver_dir}...')
+        subprocess.run(cargo_cmd, cwd=self.solver_dir, check=True)
+        for bindings_dir in glob.glob(os.path.join(self.solver_dir, '*python_bindings*')):
+            subprocess.run(cargo_cmd, cwd=bindings_dir, check=True)
+            self._refresh_python_module(bindings_dir)
+
+    def _refresh_python_module(self, bindings_dir:str):
+        profile = 'release' if self.build_type == 'release' else 'debug'
+        built_libs = glob.glob(os.path.join(bindings_dir, 'target', profile, 'lib*.so'))
+        if not built_libs:
+            return # bindings keep their opengen-built module (nothing new to copy)
+        target_so = os.path.join(self.solver_dir, self.optimizer_name + '.so')
+        shutil.copyfile(built_libs[0], target_so)
+        if self.vb:
+            print(f'{self.__print_name} Refreshed {target_so}.')
@@ -6,6 +6,8 @@ from opengen import opengen as og # or "import opengen as og"
 
 from util.mpc_config import Configurator
 
+from .interface_patch import InterfacePatcher
+
 from typing import Union, List, Callable
 
 '''
@@ -296,5 +298,9 @@ class MpcModule:
             .with_verbosity_level(1)
         builder.build()
 
+        ### Post-codegen performance patches on the generated C interface
+        patcher = InterfacePatcher(self.config.build_directory, self.config.optimizer_name, self.config.build_type)
+        patcher.apply_all()
+
         print(f'{self.__print_name} MPC module built.')
 
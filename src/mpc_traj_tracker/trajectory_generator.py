@@ -111,6 +111,7 @@ class TrajectoryGenerator:
             self.dyn_weights = [dyn_weights]*self.N_hor
         else:
             raise TypeError(f'Unsupported datatype for obstacle weights, got {type(dyn_weights)}.')
+        self.obstacle_weight_params = self.stc_weights + self.dyn_weights # constant slice of the solver parameters, baked here
 
     def set_work_mode(self, mode:str='safe'):
         '''
@@ -118,6 +119,8 @@ class TrajectoryGenerator:
             base_speed: The reference speed
             tuning_params: Penalty parameters for MPC
         '''
+        if getattr(self, 'work_mode', None) == mode:
+            return # the tuning parameters are mode-constant, no need to rebuild them every step
         nparams = 10
 
         ### Base/reference speed
@@ -136,6 +139,7 @@ class TrajectoryGenerator:
                 self.base_speed = self.config.lin_vel_max*self.config.full_speed
             else:
                 raise ModuleNotFoundError(f'There is no mode called {mode}.')
+        self.work_mode = mode
 
     def set_current_state(self, current_state: np.ndarray):
         if not isinstance(current_state, np.ndarray):
@@ -272,7 +276,7 @@ class TrajectoryGenerator:
         params = list(self.state) + list(finish_state) + list(last_u) + \
                  self.tuning_params + current_refs + speed_ref_list + \
                  other_robot_states + \
-                 stc_constraints + dyn_constraints + self.stc_weights + self.dyn_weights
+                 stc_constraints + dyn_constraints + self.obstacle_weight_params
 
         try:
             taken_states, pred_states, actions, cost, solver_time, exit_status = self.run_solver(params, self.state, self.config.action_steps, initial_guess)